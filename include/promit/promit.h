@@ -24,6 +24,7 @@
 // C standard includes.
 
 #include <stdbool.h>
+#include <stdio.h>
 
 // The SalamanderVM runtime and it's compiler backend.
 
@@ -79,6 +80,159 @@ typedef void (*PromitErrorFn)(ErrorData*);
 
 typedef void* (*PromitReallocatorFn)(void*, size_t);
 
+// The context carrying allocator function. Unlike 'PromitReallocatorFn', it 
+// receives the user data pointer it was registered with, the old size of the 
+// memory and the required alignment. The function definition should look like 
+// this: 
+// 
+// void* my_allocate(void* user_data, void* memory, size_t old_size, 
+//     size_t new_size, size_t alignment) { --CODE-- }
+// 
+// The function will be used the same way as 'PromitReallocatorFn', where 
+// [old_size] is the size [memory] was last (re)allocated with ('0' if 
+// [memory] is 'NULL') and [alignment] is a power of 2 not greater than the 
+// alignment of 'max_align_t'.
+
+typedef void* (*PromitAllocateFn)(void*, void*, size_t, size_t, size_t);
+
+// An allocator function along with it's context.
+
+typedef struct struct_PromitAllocator {
+    // The allocator function.
+
+    PromitAllocateFn allocate;
+
+    // The context passed as the first argument of [allocate].
+
+    void* user_data;
+} PromitAllocator;
+
+// The size classes of the pool allocator in bytes. Any allocation bigger than 
+// the largest class is delegated to the C standard allocator.
+
+#define PROMIT_POOL_CLASS_COUNT 6
+#define PROMIT_POOL_MIN_CLASS   16u
+#define PROMIT_POOL_MAX_CLASS   (PROMIT_POOL_MIN_CLASS << (PROMIT_POOL_CLASS_COUNT - 1))
+
+// A small object pool allocator. Memory is carved out of large blocks per 
+// size class and freed memory is kept in per class free lists for reuse. A 
+// pool is not thread-safe, use one pool per thread or per request.
+
+typedef struct struct_PromitPool {
+    // Free lists, one per size class.
+
+    void* free_lists[PROMIT_POOL_CLASS_COUNT];
+
+    // Linked list of blocks the pool has allocated.
+
+    void* blocks;
+} PromitPool;
+
+// The compiler subsystems memory allocations are attributed to.
+
+typedef enum enum_PromitMemoryTag {
+    PROMIT_MEMORY_SCANNER,
+    PROMIT_MEMORY_LINES,        // The source line index.
+    PROMIT_MEMORY_SYMBOLS,
+    PROMIT_MEMORY_AST,
+    PROMIT_MEMORY_CONSTANTS,
+    PROMIT_MEMORY_BYTECODE,
+
+    // Total number of tags, not a tag itself.
+
+    PROMIT_MEMORY_TAG_COUNT
+} PromitMemoryTag;
+
+// Memory usage of a single tag (or all of them together).
+
+typedef struct struct_PromitMemoryUsage {
+    // Bytes currently allocated.
+
+    size_t current;
+
+    // The highest [current] has ever been.
+
+    size_t peak;
+
+    // Number of times memory has been allocated or resized.
+
+    int allocations;
+} PromitMemoryUsage;
+
+// Memory accounting of a single 'promit_Compiler_compile' call. Only the 
+// memory allocated by the compiler through the configured reallocator is 
+// accounted, memory allocated by the SalamanderVM backend isn't.
+
+typedef struct struct_PromitMemoryStats {
+    // Usage per tag, indexed by 'PromitMemoryTag'.
+
+    PromitMemoryUsage tags[PROMIT_MEMORY_TAG_COUNT];
+
+    // Usage of all the tags together.
+
+    PromitMemoryUsage total;
+} PromitMemoryStats;
+
+// Time spent in a single compilation phase. All the times are in 
+// nanoseconds.
+
+typedef struct struct_PromitPhaseTime {
+    // Wall clock time when the phase was first entered, used as the event 
+    // timestamp in trace output.
+
+    long long start;
+
+    // Total wall clock time spent in the phase.
+
+    long long wall;
+
+    // Total CPU time spent in the phase.
+
+    long long cpu;
+} PromitPhaseTime;
+
+// Statistics of a single 'promit_Compiler_compile' call. The struct is filled 
+// only if it is provided through [PromitConfiguration.stats], otherwise no 
+// timing or counting is done at all.
+// 
+// Note: The compiler is single pass for now. Phases are only timed at their 
+// boundaries, [line_index] is the pass building the source line index. 
+// Tokens are scanned on demand by the parser, so the time spent scanning 
+// tokens is not available separately and, with everything else the parser 
+// does (including emission), is accounted under [parsing] until a separate 
+// optimization/emission pass exists. CPU times are of the compiling thread 
+// only.
+
+typedef struct struct_PromitCompileStats {
+    // Per phase timings.
+
+    PromitPhaseTime line_index;
+    PromitPhaseTime parsing;
+    PromitPhaseTime optimization;
+    PromitPhaseTime emission;
+
+    // Total bytes of source scanned.
+
+    size_t bytes_scanned;
+
+    // Total number of tokens the parser received from the scanner (including 
+    // EOF once).
+
+    int tokens_scanned;
+
+    // Total number of bytecode instructions emitted.
+
+    int instructions_emitted;
+
+    // Total number of constants created.
+
+    int constants_created;
+
+    // Total number of diagnostics (errors) raised.
+
+    int diagnostics;
+} PromitCompileStats;
+
 // TODO: Add configuration comments.
 
 typedef struct struct_PromitConfiguration {
@@ -90,12 +244,78 @@ typedef struct struct_PromitConfiguration {
     // reallocate memory.
 
     PromitReallocatorFn reallocator;
+
+    // The context carrying allocator. If [allocator.allocate] is 'NULL', 
+    // [reallocator] is used instead through an adapter.
+
+    PromitAllocator allocator;
+
+    // If not 'NULL', the compiler fills the pointed struct with per phase 
+    // timings and counters of the last compilation. Leaving it 'NULL' 
+    // disables the statistics altogether.
+
+    PromitCompileStats* stats;
+
+    // If not 'NULL', the compiler accounts every allocation it makes to the 
+    // pointed struct, which stays readable after compilation. Useful to 
+    // enforce memory budgets.
+
+    PromitMemoryStats* memory;
+
+    // Sources of at least this many bytes are scanned on a separate thread 
+    // while being parsed. '0' (the default) disables the pipelined scanning. 
+    // Only worth enabling on multi-core machines for very large sources. 
+    // While pipelining, the CPU time in [stats] doesn't include the scanner 
+    // thread.
+
+    size_t pipeline_threshold;
 } PromitConfiguration;
 
 // Initializes the configuration struct with deafult configurations.
 
 void promit_PromitConfiguration_init(PromitConfiguration*);
 
+// Initializes the pool allocator.
+
+void promit_Pool_init(PromitPool*);
+
+// Frees every block of the pool allocator. All the memory allocated from the 
+// pool's size classes becomes invalid.
+
+void promit_Pool_free(PromitPool*);
+
+// Returns an allocator which allocates from the provided pool, to be set as 
+// [PromitConfiguration.allocator].
+
+PromitAllocator promit_Pool_allocator(PromitPool*);
+
 CompilerKit* promit_Compiler_compile(SalamanderVM*, const char*, bool, PromitConfiguration*);
 
+// A reusable compiler. Compiling many sources (e.g. REPL lines) one after 
+// another through the same compiler reuses it's scanner and scratch buffers, 
+// so that steady state compilation doesn't allocate any compiler memory.
+
+typedef struct struct_PromitCompiler PromitCompiler;
+
+// Creates a reusable compiler. The provided configuration must outlive the 
+// compiler. Returns 'NULL' if allocation fails.
+
+PromitCompiler* promit_PromitCompiler_new(SalamanderVM*, PromitConfiguration*);
+
+// Compiles the provided source with a reusable compiler, the same way as 
+// 'promit_Compiler_compile' does.
+
+CompilerKit* promit_PromitCompiler_compile(PromitCompiler*, const char*, bool);
+
+// Frees the reusable compiler and every buffer it holds.
+
+void promit_PromitCompiler_free(PromitCompiler*);
+
+// Writes the provided array of compilation statistics as Chrome trace event 
+// JSON (to be loaded in 'chrome://tracing' or Perfetto) to the provided file. 
+// Each compilation is put in it's own track. Returns 'false' if writing 
+// fails.
+
+bool promit_CompileStats_write_trace(FILE*, const PromitCompileStats*, int);
+
 #endif    // __PROMIT_H__
\ No newline at end of file
@@ -0,0 +1,145 @@
+/**
+ * promit_pipeline.h
+ * 
+ * See the 'LICENSE' file for this file's license.
+ *
+ * This header file and it's respective C translation implements the token 
+ * pipeline, which runs the Scanner ahead on it's own thread for very large 
+ * sources. The scanner thread produces tokens into a lock-free single 
+ * producer/single consumer ring buffer and the parser consumes them from 
+ * there, so that scanning and parsing overlap.
+ * 
+ * Error tokens flow through the ring buffer in order like any other token. 
+ * The scanner thread stops once it produces the EOF token or when the 
+ * pipeline is stopped, and waits while the ring buffer is full.
+ * 
+ * The pipeline needs C11 threads and atomics. Where they aren't available, 
+ * 'promit_TokenPipeline_start' always fails and the parser scans on it's own 
+ * thread.
+ */
+
+#ifndef __PROMIT_PIPELINE_H__
+#define __PROMIT_PIPELINE_H__
+
+#include <promit_scanner.h>
+
+// C11 threads and atomics are optional, and Apple's libc doesn't provide 
+// <threads.h> at all.
+
+#if !defined __STDC_NO_THREADS__ && !defined __STDC_NO_ATOMICS__ && \
+    !defined __APPLE__
+
+#define PROMIT_PIPELINE_SUPPORTED
+
+// C standard includes.
+
+#include <stdatomic.h>
+#include <threads.h>
+
+#endif    // __STDC_NO_THREADS__, __STDC_NO_ATOMICS__ and __APPLE__
+
+// Number of token slots in the ring buffer. Must be a power of 2.
+
+#define PROMIT_PIPELINE_CAPACITY 1024u
+
+// The scanner thread and the parser only publish their position every this 
+// many tokens (or before waiting), which keeps the cache line traffic 
+// between the threads down. Must be a power of 2.
+
+#define PROMIT_PIPELINE_BATCH 64u
+
+// Maximum length of an error message carried through the pipeline 
+// (including the terminating character).
+
+#define PROMIT_PIPELINE_MESSAGE_SIZE 128u
+
+// A slot of the ring buffer. Error tokens carry a copy of their message, as 
+// the scanner may reuse the message buffer before the parser gets to it.
+
+typedef struct struct_TokenSlot {
+    Token token;
+
+    char message[PROMIT_PIPELINE_MESSAGE_SIZE];
+} TokenSlot;
+
+typedef struct struct_TokenPipeline {
+    // The scanner, owned by the scanner thread while the pipeline runs.
+
+    Scanner* scanner;
+
+    // The ring buffer of [PROMIT_PIPELINE_CAPACITY] slots.
+
+    TokenSlot* slots;
+
+#ifdef PROMIT_PIPELINE_SUPPORTED
+    // The scanner thread.
+
+    thrd_t thread;
+
+    // The fields above are only read while the pipeline runs, the indices 
+    // below are written all the time. Everything written by a different 
+    // thread is padded a cache line apart to avoid false sharing.
+
+    char shared_padding[64];
+
+    // Index of the next slot to produce into, only written by the scanner 
+    // thread.
+
+    atomic_size_t head;
+
+    char head_padding[64];
+
+    // Index of the next slot to consume from, only written by the parser.
+
+    atomic_size_t tail;
+
+    // Set by the parser to make the scanner thread quit early.
+
+    atomic_bool stop;
+
+    char tail_padding[64];
+#endif    // PROMIT_PIPELINE_SUPPORTED
+
+    // The last known [head], reloaded only when the ring buffer looks 
+    // empty.
+
+    size_t cached_head;
+
+    // Index of the next slot to consume from, [tail] lags behind it until 
+    // it's published.
+
+    size_t consumed;
+
+    // The parser holds up to 3 tokens (previous, current and next) at once, 
+    // so the messages of consumed error tokens are rotated through 3 
+    // buffers.
+
+    char messages[3][PROMIT_PIPELINE_MESSAGE_SIZE];
+
+    int message_index;
+
+    // Whether EOF has been consumed and the EOF token itself, which is 
+    // returned for every read after it.
+
+    bool eof;
+
+    Token eof_token;
+} TokenPipeline;
+
+// Starts the scanner thread with provided scanner and ring buffer of 
+// [PROMIT_PIPELINE_CAPACITY] slots. Returns 'false' if the thread couldn't be 
+// created, in which case the scanner should be used directly.
+
+bool promit_TokenPipeline_start(TokenPipeline*, Scanner*, TokenSlot*);
+
+// Returns the next token from the pipeline, waiting for the scanner thread if 
+// the ring buffer is empty.
+
+Token promit_TokenPipeline_next(TokenPipeline*);
+
+// Stops the scanner thread and waits for it to finish. The scanner can be 
+// used again afterwards.
+
+void promit_TokenPipeline_stop(TokenPipeline*);
+
+#endif    // __PROMIT_PIPELINE_H__
@@ -0,0 +1,73 @@
+/**
+ * promit_position.h
+ * 
+ * See the 'LICENSE' file for this file's license.
+ *
+ * This header file and it's respective C translation implements the position 
+ * table, a compact encoding of the source line and column of every emitted 
+ * instruction of a function. Positions are delta encoded and only stored 
+ * when they change, which takes a fraction of a byte per instruction. The 
+ * table is only ever decoded when an error or a stack trace is reported.
+ * 
+ * Encoding: Every entry starts with a header byte.
+ * 
+ *     0LLLOOOO -> Short entry. Offset delta (OOOO + 1) of 1 to 16 and line 
+ *                 delta (LLL) of 0 to 7.
+ *     10000000 -> Long entry. Followed by the offset delta as unsigned 
+ *                 varint and the line delta as zigzag varint.
+ * 
+ * Then the column follows, as a zigzag varint delta from the previous column 
+ * if the line didn't change, else as an unsigned varint.
+ */
+
+#ifndef __PROMIT_POSITION_H__
+#define __PROMIT_POSITION_H__
+
+#include <promit/promit.h>
+#include <promit_core.h>
+
+#include <stdint.h>
+
+typedef struct struct_PositionTable {
+    // The encoded entries.
+
+    uint8_t* bytes;
+
+    // Number of encoded bytes.
+
+    int count;
+
+    // Capacity of [bytes].
+
+    int capacity;
+
+    // The offset, line and column of the last entry, to encode the next 
+    // entry relative to.
+
+    int last_offset;
+    int last_line;
+    int last_column;
+} PositionTable;
+
+// Initializes the position table.
+
+void promit_PositionTable_init(PositionTable*);
+
+// Records that the instruction at provided offset (and every instruction 
+// after it, until the next record) comes from provided line and column. 
+// Offsets must be recorded in increasing order. Returns 'false' if 
+// allocation fails.
+
+bool promit_PositionTable_add(PositionTable*, PromitAllocator*, int, int, int);
+
+// Decodes the line and column of the instruction at provided offset from 
+// the provided encoded bytes. Returns 'false' if the offset comes before the 
+// first entry.
+
+bool promit_PositionTable_lookup(const uint8_t*, int, int, int*, int*);
+
+// Frees the position table.
+
+void promit_PositionTable_free(PositionTable*, PromitAllocator*);
+
+#endif    // __PROMIT_POSITION_H__
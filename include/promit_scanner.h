@@ -18,6 +18,8 @@
 #include <promit/promit.h>
 #include <promit_core.h>
 
+#include <stdint.h>
+
 // Types of token we are going to generate from the source file.
 
 typedef enum enum_TokenType {
@@ -213,9 +215,24 @@ typedef struct struct_Token {
 
     int column;
 
-    // Parsed number literal.
+    // Parsed number literal. Integer literals have it too, which may not 
+    // be exact if the integer doesn't fit in 53 bits. Hexadecimal and binary 
+    // literals are always non-negative here, e.g. '0xFFFFFFFFFFFFFFFF' is 
+    // 18446744073709551615.0.
 
     double value;
+
+    // Exact value of an integer literal. Only valid if [is_integer] is set.
+    // Hexadecimal and binary literals are 64-bit patterns reinterpreted as 
+    // signed (two's complement), e.g. '0xFFFFFFFFFFFFFFFF' is -1.
+
+    int64_t integer;
+
+    // Whether the number literal is an integer literal, i.e. a decimal 
+    // literal without fraction or exponent which fits in 64-bit signed 
+    // integer or any hexadecimal or binary literal.
+
+    bool is_integer;
 } Token;
 
 typedef struct struct_Scanner {
@@ -234,6 +251,11 @@ typedef struct struct_Scanner {
     // 1-based line number where current scanning is going on.
 
     int line_num;
+
+    // Buffer for error messages which are formatted at scan time, as error 
+    // tokens point to their message.
+
+    char error[26];
 } Scanner;
 
 // Initialize the scanner.
@@ -1,7 +1,68 @@
 /** Implements the API functions in 'promit/promit.h'. */
 
+// For 'clock_gettime' and it's monotonic and per-thread CPU clocks.
+
+#define _POSIX_C_SOURCE 199309L
+
 #include <promit/promit.h>
 #include <promit_scanner.h>
+#include <promit_pipeline.h>
+
+// C standard includes.
+
+#include <string.h>
+#include <time.h>
+
+// A reusable compiler. Keeps the scanner and every scratch buffer alive 
+// across compilations, so that compiling small snippets one after another 
+// only pays for their own tokens.
+
+struct struct_PromitCompiler {
+    // The VM.
+
+    SalamanderVM* vm;
+
+    // The Promit compiler configuration.
+
+    PromitConfiguration* config;
+
+    // The allocator every compiler allocation goes through.
+
+    PromitAllocator allocator;
+
+    // The tokenizer.
+
+    Scanner scanner;
+
+    // Copy of the last compiled source where every line is terminated with 
+    // '\0', the line index points into it.
+
+    char* text;
+
+    // Capacity of [text].
+
+    size_t text_capacity;
+
+    // The line index.
+
+    const char** lines;
+
+    // Capacity of the line index.
+
+    int line_capacity;
+
+    // Runs the scanner on it's own thread for large sources.
+
+    TokenPipeline pipeline;
+
+    // Ring buffer of the pipeline, allocated when first needed.
+
+    TokenSlot* slots;
+
+    // Bytes currently held by the compiler per memory tag.
+
+    size_t retained[PROMIT_MEMORY_TAG_COUNT];
+};
 
 // A generic parser for our compiler. Every 'promit_Compiler_compile' call has 
 // it's own parser.
@@ -19,10 +80,19 @@ typedef struct struct_Parser {
 
     Scanner* scanner;
 
+    // The pipeline to take tokens from instead of [scanner], if the source 
+    // is being scanned on a separate thread. Otherwise 'NULL'.
+
+    TokenPipeline* pipeline;
+
     // The SalamanderVM compiler backend kit.
 
     CompilerKit* kit;
     
+    // The compiler we are parsing for.
+
+    PromitCompiler* compiler;
+    
     // Current Promit compiler configuration.
 
     PromitConfiguration* config;
@@ -43,9 +113,18 @@ typedef struct struct_Parser {
 
     Token next;
 
+    // Whether the scanner has produced the EOF token. After that it just 
+    // keeps repeating it.
+
+    bool eof_scanned;
+
     // Total number of lines in the source code.
 
     int line_count;
+
+    // Length of the source code in bytes.
+
+    size_t length;
 } Parser;
 
 // Increases a 32-bit integer number and makes it a power of 2.
@@ -64,59 +143,209 @@ static inline int power_of_2(int x) {
     return x;
 }
 
-// Stores every single line in source code in a line array under parser.
+// A point in time, both in wall clock and CPU time (in nanoseconds).
 
-static void linefy(Parser* parser) {
-    PromitReallocatorFn _realloc = parser -> config -> reallocator;
+typedef struct struct_Timestamp {
+    long long wall;
+    long long cpu;
+} Timestamp;
 
-    // Flexible capacity.
+// Returns the current point in time. The wall clock is monotonic and the CPU 
+// time is of the calling thread only, where the platform provides them.
 
-    int capacity = 8, count = 0;
+static inline Timestamp timestamp_now() {
+    Timestamp stamp;
 
-    // To store the source lines.
+    struct timespec ts;
 
-    char** lines = (char**) _realloc(NULL, capacity * sizeof(char*));
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC);
+#endif    // CLOCK_MONOTONIC
 
-    char* prev, *current;
-    
-    prev = current = parser -> source;
+    stamp.wall = (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+
+#ifdef CLOCK_THREAD_CPUTIME_ID
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+
+    stamp.cpu = (long long) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#else
+    stamp.cpu = (long long) ((double) clock() * (1e9 / CLOCKS_PER_SEC));
+#endif    // CLOCK_THREAD_CPUTIME_ID
+
+    return stamp;
+}
 
-    while(*current != '\0') {
-        // If we encounter a newline, store the previous line.
+// Adds the time elapsed since [begin] to the provided phase.
 
-        if(*current == '\n') {
-            int len = (int) (current - prev);
+static inline void phase_add(PromitPhaseTime* phase, Timestamp begin) {
+    Timestamp end = timestamp_now();
 
+    // Record when the phase was first entered.
+
+    if(phase -> wall == 0 && phase -> start == 0) 
+        phase -> start = begin.wall;
+
+    phase -> wall += end.wall - begin.wall;
+    phase -> cpu  += end.cpu  - begin.cpu;
+}
+
+// Adapts a 'PromitReallocatorFn' to the 'PromitAllocateFn' interface. 
+// [user_data] points to the reallocator function.
+
+static void* reallocator_adapter(void* user_data, void* memory, 
+    size_t old_size, size_t new_size, size_t alignment) 
+{
+    (void) old_size;
+    (void) alignment;
+
+    PromitReallocatorFn reallocator = *(PromitReallocatorFn*) user_data;
+
+    return reallocator(memory, new_size);
+}
+
+// Allocates, resizes or frees (when [new_size] is 0) memory through the 
+// configured allocator and accounts it under provided tag, if memory 
+// accounting is enabled. [old_size] must be the size [memory] was last 
+// allocated with (0 if [memory] is 'NULL').
+
+static void* reallocate(PromitCompiler* compiler, PromitMemoryTag tag, 
+    void* memory, size_t old_size, size_t new_size, size_t alignment) 
+{
+    void* result = compiler -> allocator.allocate(
+        compiler -> allocator.user_data, memory, old_size, new_size, 
+        alignment);
+
+    // A failed allocation leaves [memory] as it was, so there is nothing to 
+    // account.
+
+    if(unlikely(result == NULL && new_size != 0u)) 
+        return NULL;
+
+    PromitMemoryStats* stats = compiler -> config -> memory;
+
+    compiler -> retained[tag] = compiler -> retained[tag] - old_size + new_size;
+
+    if(unlikely(stats != NULL)) {
+        PromitMemoryUsage* usages[2] = { &stats -> tags[tag], &stats -> total };
+
+        for(int i = 0; i < 2; i++) {
+            PromitMemoryUsage* usage = usages[i];
+
+            usage -> current = usage -> current - old_size + new_size;
+
+            if(usage -> current > usage -> peak) 
+                usage -> peak = usage -> current;
+
+            if(new_size != 0u) 
+                usage -> allocations++;
+        }
+    }
+
+    return result;
+}
+
+// Stores every single line in source code in a line array under parser. The 
+// lines are stored in the compiler's buffers, which only grow when a source 
+// bigger than any of the previous ones comes along. Returns 'false' if 
+// allocation fails.
+
+static bool linefy(Parser* parser) {
+    PromitCompiler* compiler = parser -> compiler;
+
+    size_t length = strlen(parser -> source) + 1u;
+
+    // Grow the text buffer if the source doesn't fit.
+
+    if(unlikely(length > compiler -> text_capacity)) {
+        size_t capacity = compiler -> text_capacity == 0u ? 
+            64u : compiler -> text_capacity;
+
+        while(capacity < length) 
+            capacity <<= 1u;
+        
+        // The old text is useless, so free it instead of copying it over.
+
+        reallocate(compiler, PROMIT_MEMORY_LINES, compiler -> text, 
+            compiler -> text_capacity * sizeof(char), 0u, _Alignof(char));
+
+        compiler -> text          = NULL;
+        compiler -> text_capacity = 0u;
+
+        char* text = (char*) reallocate(compiler, PROMIT_MEMORY_LINES, NULL, 
+            0u, capacity * sizeof(char), _Alignof(char));
+        
+        if(unlikely(text == NULL)) 
+            return false;
+
+        compiler -> text          = text;
+        compiler -> text_capacity = capacity;
+    }
+
+    memcpy(compiler -> text, parser -> source, length * sizeof(char));
+
+    int count = 0;
+
+    char* line = compiler -> text;
+
+    for(char* current = compiler -> text; ; current++) {
+        // If we encounter a newline or the end of source, store the previous 
+        // line. The last line is stored even if it's empty, as tokens (e.g. 
+        // EOF) can still be on it.
+
+        if(*current == '\n' || *current == '\0') {
             // Increase the capacity if overflows.
 
-            if(count + 1 > capacity) {
-                capacity = power_of_2(count + 1);
+            if(unlikely(count + 1 > compiler -> line_capacity)) {
+                int capacity = power_of_2(count + 1);
 
-                lines = (char**) _realloc(lines, capacity);
-            }
+                if(capacity < 8) 
+                    capacity = 8;
 
-            char* line = (char*) _realloc(NULL, (len + 1) * sizeof(char));
+                const char** lines = (const char**) reallocate(compiler, 
+                    PROMIT_MEMORY_LINES, (void*) compiler -> lines, 
+                    compiler -> line_capacity * sizeof(char*), 
+                    capacity * sizeof(char*), _Alignof(char*));
+                
+                // The old line index is still valid, keep it to be freed 
+                // later.
 
-            memcpy(line, prev, len * sizeof(char));
+                if(unlikely(lines == NULL)) 
+                    return false;
 
-            line[len] = '\0';
+                compiler -> lines         = lines;
+                compiler -> line_capacity = capacity;
+            }
 
             // Store the line.
 
-            lines[count++] = line;
+            compiler -> lines[count++] = line;
+
+            if(*current == '\0') 
+                break;
+
+            // Terminate the line and go to the next one.
 
-            // Go to next line/character.
+            *current = '\0';
 
-            prev = current = current + 1u;
+            line = current + 1u;
         }
     }
 
     // Set the stored lines.
 
-    parser -> lines = lines;
+    parser -> lines      = compiler -> lines;
+    parser -> line_count = count;
+    parser -> length     = length - 1u;
+
+    return true;
 }
 
 static void error(Parser* parser, Token token, const char* message) {
+    if(unlikely(parser -> config -> stats != NULL)) 
+        parser -> config -> stats -> diagnostics++;
+
     // If we don't have any error function to dump our error to, do nothing.
 
     if(unlikely(parser -> config -> error == NULL)) 
@@ -127,7 +356,8 @@ static void error(Parser* parser, Token token, const char* message) {
     // Fill the data.
 
     data.message  = message;
-    data.line     = parser -> lines[token.line - 1];
+    data.line     = token.line >= 1 && token.line <= parser -> line_count ? 
+        parser -> lines[token.line - 1] : "";
     data.column   = token.column;
     data.module   = "dummy";    // TODO: Add module name.
     data.length   = token.length;
@@ -155,6 +385,15 @@ static void consume(Parser* parser, TokenType type, const char* errmsg) {
     error_at_current(parser, errmsg);
 }
 
+// Returns the next token, either from the pipeline or the scanner directly.
+
+static inline Token next_token(Parser* parser) {
+    if(unlikely(parser -> pipeline != NULL)) 
+        return promit_TokenPipeline_next(parser -> pipeline);
+    
+    return promit_Scanner_next_token(parser -> scanner);
+}
+
 // Advances one token each.
 //     previous = current
 //     current  = next
@@ -164,7 +403,16 @@ static void advance(Parser* parser) {
     parser -> previous = parser -> current;
     parser -> current  = parser -> next;
 
-    parser -> next = promit_Scanner_next_token(parser -> scanner);
+    parser -> next = next_token(parser);
+
+    // Count every token the scanner produces, but not the repeated EOFs.
+
+    if(!parser -> eof_scanned) {
+        if(unlikely(parser -> config -> stats != NULL)) 
+            parser -> config -> stats -> tokens_scanned++;
+
+        parser -> eof_scanned = parser -> next.type == TOKEN_EOF;
+    }
 
     // If we find any error in the scanning, ...
 
@@ -173,62 +421,275 @@ static void advance(Parser* parser) {
 
         if(unlikely(parser -> current.type == TOKEN_ERROR)) return;
 
-        error_at_current(parser, parser -> current.start);
+        // Error tokens carry their message in place of the lexeme.
+
+        error(parser, parser -> next, parser -> next.start);
     }
 }
 
-// Initializes the parser and makes it ready to rock.
+// Initializes the parser and makes it ready to rock. Returns 'false' (after 
+// reporting it) if the parser couldn't be initialized.
 
-static void parser_init(SalamanderVM* vm, Parser* parser, Scanner* scanner, 
-    CompilerKit* kit, const char* source, PromitConfiguration* config) 
+static bool parser_init(PromitCompiler* compiler, Parser* parser, 
+    CompilerKit* kit, const char* source) 
 {
-    promit_Scanner_init(scanner, source);
+    promit_Scanner_init(&compiler -> scanner, source);
+
+    parser -> source      = source;
+    parser -> vm          = compiler -> vm;
+    parser -> scanner     = &compiler -> scanner;
+    parser -> kit         = kit;
+    parser -> compiler    = compiler;
+    parser -> config      = compiler -> config;
+    parser -> pipeline    = NULL;
+    parser -> lines       = NULL;
+    parser -> eof_scanned = false;
+    parser -> line_count  = 0;
+    parser -> length      = 0u;
+
+    // Nothing is lexed yet.
+
+    memset(&parser -> current, 0, sizeof(Token));
+    memset(&parser -> next, 0, sizeof(Token));
+
+    // Building the line index is timed as a phase of its own.
+
+    bool indexed;
+
+    if(unlikely(parser -> config -> stats != NULL)) {
+        Timestamp begin = timestamp_now();
+
+        indexed = linefy(parser);
+
+        phase_add(&parser -> config -> stats -> line_index, begin);
+    }
+    else indexed = linefy(parser);
+
+    if(unlikely(!indexed)) {
+        error(parser, parser -> current, 
+            "Out of memory while indexing the source lines!");
+
+        return false;
+    }
 
-    parser -> source     = source;
-    parser -> vm         = vm;
-    parser -> scanner    = scanner;
-    parser -> kit        = kit;
-    parser -> config     = config;
-    parser -> lines      = NULL;
-    parser -> line_count = 0;
+    // Scan very large sources on a separate thread, while we parse.
 
-    linefy(parser);
+    size_t threshold = parser -> config -> pipeline_threshold;
+
+    if(unlikely(threshold != 0u && parser -> length >= threshold)) {
+        if(compiler -> slots == NULL) {
+            compiler -> slots = (TokenSlot*) reallocate(compiler, 
+                PROMIT_MEMORY_SCANNER, NULL, 0u, 
+                PROMIT_PIPELINE_CAPACITY * sizeof(TokenSlot), 
+                _Alignof(TokenSlot));
+        }
+
+        // Fall back to scanning on this thread if anything fails.
+
+        if(likely(compiler -> slots != NULL) && 
+            promit_TokenPipeline_start(&compiler -> pipeline, 
+                &compiler -> scanner, compiler -> slots)) 
+        {
+            parser -> pipeline = &compiler -> pipeline;
+        }
+    }
 
     advance(parser);    // Loads the current token.
     advance(parser);    // Loads the next token.
+
+    return true;
+}
+
+// Initializes the compiler.
+
+static void compiler_init(PromitCompiler* compiler, SalamanderVM* vm, 
+    PromitConfiguration* config) 
+{
+    compiler -> vm            = vm;
+    compiler -> config        = config;
+    compiler -> text          = NULL;
+    compiler -> text_capacity = 0u;
+    compiler -> lines         = NULL;
+    compiler -> line_capacity = 0;
+    compiler -> slots         = NULL;
+
+    for(int i = 0; i < PROMIT_MEMORY_TAG_COUNT; i++) 
+        compiler -> retained[i] = 0u;
+
+    // Without a context carrying allocator, adapt the plain reallocator.
+
+    if(likely(config -> allocator.allocate == NULL)) {
+        compiler -> allocator.allocate  = reallocator_adapter;
+        compiler -> allocator.user_data = &config -> reallocator;
+    }
+    else compiler -> allocator = config -> allocator;
 }
 
-// Frees the parser.
+// Releases every buffer the compiler holds.
 
-static void parser_free(Parser* parser) {
-    for(int i = 0; i < parser -> line_count; i++) 
-        parser -> config -> reallocator(parser -> lines[i], 0u);
+static void compiler_release(PromitCompiler* compiler) {
+    reallocate(compiler, PROMIT_MEMORY_LINES, compiler -> text, 
+        compiler -> text_capacity * sizeof(char), 0u, _Alignof(char));
+    
+    reallocate(compiler, PROMIT_MEMORY_LINES, (void*) compiler -> lines, 
+        compiler -> line_capacity * sizeof(char*), 0u, _Alignof(char*));
     
-    parser -> config -> reallocator(parser -> lines, 0u);
+    reallocate(compiler, PROMIT_MEMORY_SCANNER, compiler -> slots, 
+        compiler -> slots != NULL ? 
+            PROMIT_PIPELINE_CAPACITY * sizeof(TokenSlot) : 0u, 
+        0u, _Alignof(TokenSlot));
+
+    compiler -> slots         = NULL;
+    compiler -> text          = NULL;
+    compiler -> text_capacity = 0u;
+    compiler -> lines         = NULL;
+    compiler -> line_capacity = 0;
 }
 
-CompilerKit* promit_Compiler_compile(SalamanderVM* vm, const char* source, 
-    bool print_errors, PromitConfiguration* config) 
+// Resets the memory accounting for a new compilation. The buffers the 
+// compiler still holds from previous compilations are accounted as already 
+// in use.
+
+static void memory_reset(PromitCompiler* compiler) {
+    PromitMemoryStats* stats = compiler -> config -> memory;
+
+    memset(stats, 0, sizeof(PromitMemoryStats));
+
+    for(int i = 0; i < PROMIT_MEMORY_TAG_COUNT; i++) {
+        stats -> tags[i].current = stats -> tags[i].peak = 
+            compiler -> retained[i];
+        
+        stats -> total.current += compiler -> retained[i];
+    }
+
+    stats -> total.peak = stats -> total.current;
+}
+
+// Compiles the provided source with provided compiler.
+
+static CompilerKit* compile(PromitCompiler* compiler, const char* source, 
+    bool print_errors) 
 {
-    CompilerKit* kit = salamander_CompilerKit_new(vm);
+    (void) print_errors;
 
-    // Each compilation call has it's own scanner and parser object.
+    PromitConfiguration* config = compiler -> config;
 
-    Scanner scanner;
+    CompilerKit* kit = salamander_CompilerKit_new(compiler -> vm);
+
+    // Each compilation call has it's own parser object.
 
     Parser parser;
+
+    PromitCompileStats* stats = config -> stats;
+
+    Timestamp begin;
+
+    if(unlikely(stats != NULL)) {
+        memset(stats, 0, sizeof(PromitCompileStats));
+
+        begin = timestamp_now();
+    }
+
+    if(unlikely(config -> memory != NULL)) 
+        memory_reset(compiler);
     
-    // Initialize the parser.
+    // Initialize the parser, there is nothing to compile if it fails.
 
-    parser_init(vm, &parser, &scanner, kit, source, config);
+    if(unlikely(!parser_init(compiler, &parser, kit, source))) 
+        return kit;
 
     expresssion(&parser);
 
     consume(&parser, TOKEN_EOF, "Expected an end of expression!");
 
-    // Release the parser.
+    // Wait for the scanner thread to finish, the scanner is ours again.
+
+    if(unlikely(parser.pipeline != NULL)) 
+        promit_TokenPipeline_stop(parser.pipeline);
+
+    if(unlikely(stats != NULL)) {
+        phase_add(&stats -> parsing, begin);
+
+        // The line index is built in one go during the parser 
+        // initialization, so take it out of the parsing time and start 
+        // parsing where it ends. This way the phases follow each other.
 
-    parser_free(&parser);
+        stats -> parsing.wall -= stats -> line_index.wall;
+        stats -> parsing.cpu  -= stats -> line_index.cpu;
+
+        if(likely(stats -> line_index.wall != 0)) 
+            stats -> parsing.start = 
+                stats -> line_index.start + stats -> line_index.wall;
+
+        stats -> bytes_scanned = 
+            (size_t) (compiler -> scanner.current - source);
+    }
 
     return kit;
+}
+
+CompilerKit* promit_Compiler_compile(SalamanderVM* vm, const char* source, 
+    bool print_errors, PromitConfiguration* config) 
+{
+    // A one-shot compilation uses a throwaway compiler.
+
+    PromitCompiler compiler;
+
+    compiler_init(&compiler, vm, config);
+
+    CompilerKit* kit = compile(&compiler, source, print_errors);
+
+    compiler_release(&compiler);
+
+    return kit;
+}
+
+// PromitCompiler* promit_PromitCompiler_new(SalamanderVM*, 
+//     PromitConfiguration*);
+// 
+// Creates a reusable compiler.
+
+PromitCompiler* promit_PromitCompiler_new(SalamanderVM* vm, 
+    PromitConfiguration* config) 
+{
+    PromitCompiler compiler;
+
+    compiler_init(&compiler, vm, config);
+
+    // The compiler itself isn't attributed to any subsystem.
+
+    PromitCompiler* result = (PromitCompiler*) compiler.allocator.allocate(
+        compiler.allocator.user_data, NULL, 0u, sizeof(PromitCompiler), 
+        _Alignof(PromitCompiler));
+
+    if(unlikely(result == NULL)) 
+        return NULL;
+
+    *result = compiler;
+
+    return result;
+}
+
+// CompilerKit* promit_PromitCompiler_compile(PromitCompiler*, const char*, 
+//     bool);
+// 
+// Compiles the provided source with a reusable compiler.
+
+CompilerKit* promit_PromitCompiler_compile(PromitCompiler* compiler, 
+    const char* source, bool print_errors) 
+{
+    return compile(compiler, source, print_errors);
+}
+
+// void promit_PromitCompiler_free(PromitCompiler*);
+// 
+// Frees the reusable compiler and every buffer it holds.
+
+void promit_PromitCompiler_free(PromitCompiler* compiler) {
+    compiler_release(compiler);
+
+    PromitAllocator allocator = compiler -> allocator;
+
+    allocator.allocate(allocator.user_data, compiler, sizeof(PromitCompiler), 
+        0u, _Alignof(PromitCompiler));
 }
\ No newline at end of file
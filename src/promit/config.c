@@ -35,4 +35,17 @@ void promit_PromitConfiguration_init(PromitConfiguration* config) {
 
     config -> error       = NULL;                   // No error function.
     config -> reallocator = default_reallocator;
+
+    // No context carrying allocator, use [reallocator].
+
+    config -> allocator.allocate  = NULL;
+    config -> allocator.user_data = NULL;
+
+    config -> stats       = NULL;                   // No statistics.
+    config -> memory      = NULL;                   // No memory accounting.
+
+    // Pipelined scanning is opt-in, it only pays off for very large sources 
+    // on multi-core machines.
+
+    config -> pipeline_threshold = 0u;
 }
\ No newline at end of file
@@ -0,0 +1,195 @@
+/** Implements the API functions in 'promit/promit.h'. */
+
+#include <promit/promit.h>
+#include <promit_core.h>
+
+// C standard includes.
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Size of every block the pool carves it's chunks out of.
+
+#define BLOCK_SIZE (64u * 1024u)
+
+// Header of a pool block, chunks follow right after it. The union makes sure 
+// the chunks are aligned to 'max_align_t'.
+
+typedef union union_Block {
+    union union_Block* next;
+
+    max_align_t alignment;
+} Block;
+
+// A freed chunk, linked into it's size class's free list.
+
+typedef struct struct_Chunk {
+    struct struct_Chunk* next;
+} Chunk;
+
+// Returns the size class index of provided size or -1, if the size is bigger 
+// than the largest class.
+
+static int size_class(size_t size) {
+    if(unlikely(size > PROMIT_POOL_MAX_CLASS)) 
+        return -1;
+    
+    int index = 0;
+
+    for(size_t class_size = PROMIT_POOL_MIN_CLASS; class_size < size; 
+        class_size <<= 1u) 
+    {
+        index++;
+    }
+
+    return index;
+}
+
+// Takes a chunk from provided size class, allocating a new block if the free 
+// list is empty.
+
+static void* take_chunk(PromitPool* pool, int index) {
+    Chunk* chunk = (Chunk*) pool -> free_lists[index];
+
+    if(unlikely(chunk == NULL)) {
+        Block* block = (Block*) malloc(BLOCK_SIZE);
+
+        if(unlikely(block == NULL)) 
+            return NULL;
+        
+        block -> next = (Block*) pool -> blocks;
+        pool -> blocks = block;
+
+        size_t class_size = PROMIT_POOL_MIN_CLASS << index;
+
+        char* current = (char*) (block + 1);
+        char* end     = (char*) block + BLOCK_SIZE;
+
+        // Carve the block into chunks and put them all in the free list.
+
+        for(; current + class_size <= end; current += class_size) {
+            chunk = (Chunk*) current;
+
+            chunk -> next = (Chunk*) pool -> free_lists[index];
+            pool -> free_lists[index] = chunk;
+        }
+    }
+
+    pool -> free_lists[index] = chunk -> next;
+
+    return chunk;
+}
+
+// Puts a chunk back to provided size class's free list.
+
+static void give_chunk(PromitPool* pool, int index, void* memory) {
+    Chunk* chunk = (Chunk*) memory;
+
+    chunk -> next = (Chunk*) pool -> free_lists[index];
+    pool -> free_lists[index] = chunk;
+}
+
+// The 'PromitAllocateFn' of the pool, where [user_data] is the pool.
+
+static void* pool_allocate(void* user_data, void* memory, size_t old_size, 
+    size_t new_size, size_t alignment) 
+{
+    PromitPool* pool = (PromitPool*) user_data;
+
+    // Chunks and the C standard allocator are only aligned to 'max_align_t'.
+
+    if(unlikely(alignment > _Alignof(max_align_t))) 
+        return NULL;
+
+    int old_class = memory != NULL ? size_class(old_size) : -1;
+
+    // Deallocation.
+
+    if(new_size == 0u) {
+        if(old_class >= 0) 
+            give_chunk(pool, old_class, memory);
+        else 
+            free(memory);
+        
+        return NULL;
+    }
+
+    int new_class = size_class(new_size);
+
+    // Allocation.
+
+    if(memory == NULL) 
+        return new_class >= 0 ? take_chunk(pool, new_class) : malloc(new_size);
+    
+    // Reallocation within the same size class, nothing to do.
+
+    if(new_class == old_class && new_class >= 0) 
+        return memory;
+    
+    // Both are too large to be pooled.
+
+    if(new_class < 0 && old_class < 0) 
+        return realloc(memory, new_size);
+    
+    // Moving between classes (or in and out of the pool).
+
+    void* result = new_class >= 0 ? take_chunk(pool, new_class) : 
+        malloc(new_size);
+
+    if(unlikely(result == NULL)) 
+        return NULL;
+    
+    memcpy(result, memory, old_size < new_size ? old_size : new_size);
+
+    if(old_class >= 0) 
+        give_chunk(pool, old_class, memory);
+    else 
+        free(memory);
+
+    return result;
+}
+
+// void promit_Pool_init(PromitPool*);
+// 
+// Initializes the pool allocator.
+
+void promit_Pool_init(PromitPool* pool) {
+    for(int i = 0; i < PROMIT_POOL_CLASS_COUNT; i++) 
+        pool -> free_lists[i] = NULL;
+    
+    pool -> blocks = NULL;
+}
+
+// void promit_Pool_free(PromitPool*);
+// 
+// Frees every block of the pool allocator. All the memory allocated from the 
+// pool's size classes becomes invalid.
+
+void promit_Pool_free(PromitPool* pool) {
+    Block* block = (Block*) pool -> blocks;
+
+    while(block != NULL) {
+        Block* next = block -> next;
+
+        free(block);
+
+        block = next;
+    }
+
+    promit_Pool_init(pool);
+}
+
+// PromitAllocator promit_Pool_allocator(PromitPool*);
+// 
+// Returns an allocator which allocates from the provided pool, to be set as 
+// [PromitConfiguration.allocator].
+
+PromitAllocator promit_Pool_allocator(PromitPool* pool) {
+    PromitAllocator allocator;
+
+    allocator.allocate  = pool_allocate;
+    allocator.user_data = pool;
+
+    return allocator;
+}
@@ -0,0 +1,70 @@
+/** Implements the API functions in 'promit/promit.h'. */
+
+#include <promit/promit.h>
+
+// Writes a single complete ('X') trace event of the provided phase.
+
+static bool write_phase(FILE* file, const char* name, 
+    const PromitPhaseTime* phase, int track, bool* first) 
+{
+    // Never entered phases are not worth a trace event.
+
+    if(phase -> wall == 0) 
+        return true;
+
+    // Trace event timestamps and durations are in microseconds.
+
+    int result = fprintf(file, 
+        "%s\n    {\"name\": \"%s\", \"cat\": \"compile\", \"ph\": \"X\", "
+        "\"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, "
+        "\"args\": {\"cpu_us\": %.3f}}", 
+        *first ? "" : ",", name, track, phase -> start / 1000.0, 
+        phase -> wall / 1000.0, phase -> cpu / 1000.0);
+
+    *first = false;
+
+    return result >= 0;
+}
+
+// bool promit_CompileStats_write_trace(FILE*, const PromitCompileStats*, 
+//     int);
+// 
+// Writes the provided array of compilation statistics as Chrome trace event 
+// JSON (to be loaded in 'chrome://tracing' or Perfetto) to the provided file. 
+// Each compilation is put in it's own track. Returns 'false' if writing 
+// fails.
+
+bool promit_CompileStats_write_trace(FILE* file, 
+    const PromitCompileStats* stats, int count) 
+{
+    bool first = true, ok = fprintf(file, "{\"traceEvents\": [") >= 0;
+
+    for(int i = 0; ok && i < count; i++) {
+        const PromitCompileStats* current = stats + i;
+
+        ok = write_phase(file, "line index", &current -> line_index, i, 
+                 &first) &&
+             write_phase(file, "parsing", &current -> parsing, i, &first) && 
+             write_phase(file, "optimization", &current -> optimization, i, 
+                 &first) && 
+             write_phase(file, "emission", &current -> emission, i, &first);
+        
+        // The counters are put as a counter ('C') event.
+
+        if(ok) {
+            ok = fprintf(file, 
+                "%s\n    {\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, "
+                "\"tid\": %d, \"ts\": %.3f, \"args\": {\"bytes\": %zu, "
+                "\"tokens\": %d, \"instructions\": %d, \"constants\": %d, "
+                "\"diagnostics\": %d}}", 
+                first ? "" : ",", i, current -> parsing.start / 1000.0, 
+                current -> bytes_scanned, current -> tokens_scanned, 
+                current -> instructions_emitted, current -> constants_created, 
+                current -> diagnostics) >= 0;
+
+            first = false;
+        }
+    }
+
+    return ok && fprintf(file, "\n]}\n") >= 0;
+}
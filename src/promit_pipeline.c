@@ -0,0 +1,229 @@
+#include <promit_pipeline.h>
+
+// Standard C includes.
+
+#include <string.h>
+
+#ifdef PROMIT_PIPELINE_SUPPORTED
+
+#define MASK (PROMIT_PIPELINE_CAPACITY - 1u)
+
+// Number of times a waiting thread just yields before it starts sleeping.
+
+#define SPIN_ROUNDS 64
+
+// Waits for the other thread to catch up. Yields for the first few rounds 
+// and sleeps afterwards, so that a waiting thread doesn't burn a whole core.
+
+static void backoff(int* rounds) {
+    if(likely(*rounds < SPIN_ROUNDS)) {
+        (*rounds)++;
+
+        thrd_yield();
+
+        return;
+    }
+
+    struct timespec duration = { 0, 50000L };    // 50 microseconds.
+
+    thrd_sleep(&duration, NULL);
+}
+
+// Copies an error message into provided buffer, truncating it if needed, and 
+// points the token to the copy.
+
+static void copy_message(Token* token, char* buffer) {
+    size_t length = (size_t) token -> length;
+
+    if(unlikely(length > PROMIT_PIPELINE_MESSAGE_SIZE - 1u)) 
+        length = PROMIT_PIPELINE_MESSAGE_SIZE - 1u;
+    
+    memcpy(buffer, token -> start, length * sizeof(char));
+
+    buffer[length] = '\0';
+
+    token -> start  = buffer;
+    token -> length = (int) length;
+}
+
+// The scanner thread.
+
+static int produce(void* argument) {
+    TokenPipeline* pipeline = (TokenPipeline*) argument;
+
+    size_t head = atomic_load_explicit(&pipeline -> head, 
+        memory_order_relaxed);
+    
+    // The last known consumer position, reloaded only when the ring buffer 
+    // looks full.
+
+    size_t tail = atomic_load_explicit(&pipeline -> tail, 
+        memory_order_acquire);
+
+    while(true) {
+        // Wait for the parser if the ring buffer is full. Publish everything 
+        // produced so far first, so that the parser doesn't wait for us 
+        // while we wait for it.
+
+        if(unlikely(head - tail == PROMIT_PIPELINE_CAPACITY)) {
+            atomic_store_explicit(&pipeline -> head, head, 
+                memory_order_release);
+            
+            tail = atomic_load_explicit(&pipeline -> tail, 
+                memory_order_acquire);
+        }
+
+        int rounds = 0;
+
+        while(unlikely(head - tail == PROMIT_PIPELINE_CAPACITY)) {
+            if(atomic_load_explicit(&pipeline -> stop, memory_order_relaxed)) 
+                return 0;
+            
+            backoff(&rounds);
+
+            tail = atomic_load_explicit(&pipeline -> tail, 
+                memory_order_acquire);
+        }
+
+        TokenSlot* slot = &pipeline -> slots[head & MASK];
+
+        slot -> token = promit_Scanner_next_token(pipeline -> scanner);
+
+        if(unlikely(slot -> token.type == TOKEN_ERROR)) 
+            copy_message(&slot -> token, slot -> message);
+        
+        head++;
+
+        // Publish the slots produced in this batch. EOF is published right 
+        // away as nothing comes after it.
+
+        if(unlikely(slot -> token.type == TOKEN_EOF)) {
+            atomic_store_explicit(&pipeline -> head, head, 
+                memory_order_release);
+            
+            return 0;
+        }
+
+        if((head & (PROMIT_PIPELINE_BATCH - 1u)) == 0u) 
+            atomic_store_explicit(&pipeline -> head, head, 
+                memory_order_release);
+    }
+}
+
+// bool promit_TokenPipeline_start(TokenPipeline*, Scanner*, TokenSlot*);
+// 
+// Starts the scanner thread with provided scanner and ring buffer of 
+// [PROMIT_PIPELINE_CAPACITY] slots. Returns 'false' if the thread couldn't be 
+// created, in which case the scanner should be used directly.
+
+bool promit_TokenPipeline_start(TokenPipeline* pipeline, Scanner* scanner, 
+    TokenSlot* slots) 
+{
+    pipeline -> scanner       = scanner;
+    pipeline -> slots         = slots;
+    pipeline -> cached_head   = 0u;
+    pipeline -> consumed      = 0u;
+    pipeline -> message_index = 0;
+    pipeline -> eof           = false;
+
+    atomic_init(&pipeline -> head, 0u);
+    atomic_init(&pipeline -> tail, 0u);
+    atomic_init(&pipeline -> stop, false);
+
+    return thrd_create(&pipeline -> thread, produce, pipeline) == thrd_success;
+}
+
+// Token promit_TokenPipeline_next(TokenPipeline*);
+// 
+// Returns the next token from the pipeline, waiting for the scanner thread if 
+// the ring buffer is empty.
+
+Token promit_TokenPipeline_next(TokenPipeline* pipeline) {
+    // The scanner thread is done after EOF, keep returning it like the 
+    // scanner does.
+
+    if(unlikely(pipeline -> eof)) 
+        return pipeline -> eof_token;
+
+    size_t tail = pipeline -> consumed;
+
+    // Wait for the scanner thread if the ring buffer is empty. Release 
+    // every consumed slot first, so that the scanner thread doesn't wait for 
+    // us while we wait for it.
+
+    if(unlikely(tail == pipeline -> cached_head)) 
+        atomic_store_explicit(&pipeline -> tail, tail, memory_order_release);
+
+    int rounds = 0;
+
+    while(unlikely(tail == pipeline -> cached_head)) {
+        pipeline -> cached_head = atomic_load_explicit(&pipeline -> head, 
+            memory_order_acquire);
+        
+        if(tail == pipeline -> cached_head) 
+            backoff(&rounds);
+    }
+
+    TokenSlot* slot = &pipeline -> slots[tail & MASK];
+
+    Token token = slot -> token;
+
+    // The slot is reused once it's released, so move the message out of it.
+
+    if(unlikely(token.type == TOKEN_ERROR)) {
+        copy_message(&token, pipeline -> messages[pipeline -> message_index]);
+
+        pipeline -> message_index = (pipeline -> message_index + 1) % 3;
+    }
+    else if(unlikely(token.type == TOKEN_EOF)) {
+        pipeline -> eof       = true;
+        pipeline -> eof_token = token;
+    }
+
+    // Release the slots consumed in this batch.
+
+    pipeline -> consumed = ++tail;
+
+    if((tail & (PROMIT_PIPELINE_BATCH - 1u)) == 0u) 
+        atomic_store_explicit(&pipeline -> tail, tail, memory_order_release);
+
+    return token;
+}
+
+// void promit_TokenPipeline_stop(TokenPipeline*);
+// 
+// Stops the scanner thread and waits for it to finish. The scanner can be 
+// used again afterwards.
+
+void promit_TokenPipeline_stop(TokenPipeline* pipeline) {
+    atomic_store_explicit(&pipeline -> stop, true, memory_order_relaxed);
+
+    thrd_join(pipeline -> thread, NULL);
+}
+
+#undef MASK
+#undef SPIN_ROUNDS
+
+#else
+
+// Without C11 threads and atomics the pipeline never starts, so the parser 
+// always scans on it's own thread.
+
+bool promit_TokenPipeline_start(TokenPipeline* pipeline, Scanner* scanner, 
+    TokenSlot* slots) 
+{
+    pipeline -> scanner = scanner;
+    pipeline -> slots   = slots;
+
+    return false;
+}
+
+Token promit_TokenPipeline_next(TokenPipeline* pipeline) {
+    return promit_Scanner_next_token(pipeline -> scanner);
+}
+
+void promit_TokenPipeline_stop(TokenPipeline* pipeline) {
+    (void) pipeline;
+}
+
+#endif    // PROMIT_PIPELINE_SUPPORTED
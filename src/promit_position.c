@@ -0,0 +1,216 @@
+#include <promit_position.h>
+
+// Makes sure the table has room for provided number of bytes.
+
+static bool reserve(PositionTable* table, PromitAllocator* allocator, 
+    int size) 
+{
+    if(likely(table -> count + size <= table -> capacity)) 
+        return true;
+    
+    int capacity = table -> capacity == 0 ? 16 : table -> capacity;
+
+    while(capacity < table -> count + size) 
+        capacity <<= 1;
+    
+    uint8_t* bytes = (uint8_t*) allocator -> allocate(allocator -> user_data, 
+        table -> bytes, (size_t) table -> capacity, (size_t) capacity, 
+        _Alignof(uint8_t));
+    
+    if(unlikely(bytes == NULL)) 
+        return false;
+    
+    table -> bytes    = bytes;
+    table -> capacity = capacity;
+
+    return true;
+}
+
+// Writes an unsigned varint, 7 bits per byte with the high bit set on every 
+// byte but the last.
+
+static void write_varint(PositionTable* table, uint32_t value) {
+    while(value >= 0x80u) {
+        table -> bytes[table -> count++] = (uint8_t) (value | 0x80u);
+
+        value >>= 7;
+    }
+
+    table -> bytes[table -> count++] = (uint8_t) value;
+}
+
+// Writes a signed varint, zigzag encoded so that small negative numbers 
+// stay small.
+
+static void write_svarint(PositionTable* table, int value) {
+    write_varint(table, ((uint32_t) value << 1) ^ (uint32_t) (value >> 31));
+}
+
+// Reads an unsigned varint.
+
+static uint32_t read_varint(const uint8_t** bytes) {
+    uint32_t value = 0u;
+
+    int shift = 0;
+
+    uint8_t byte;
+
+    do {
+        byte = *(*bytes)++;
+
+        value |= (uint32_t) (byte & 0x7Fu) << shift;
+
+        shift += 7;
+    } while(byte & 0x80u);
+
+    return value;
+}
+
+// Reads a signed (zigzag encoded) varint.
+
+static int read_svarint(const uint8_t** bytes) {
+    uint32_t value = read_varint(bytes);
+
+    return (int) (value >> 1) ^ -(int) (value & 1u);
+}
+
+// void promit_PositionTable_init(PositionTable*);
+// 
+// Initializes the position table.
+
+void promit_PositionTable_init(PositionTable* table) {
+    table -> bytes       = NULL;
+    table -> count       = 0;
+    table -> capacity    = 0;
+    table -> last_offset = 0;
+    table -> last_line   = 1;
+    table -> last_column = 0;
+}
+
+// bool promit_PositionTable_add(PositionTable*, PromitAllocator*, int, int, 
+//     int);
+// 
+// Records that the instruction at provided offset (and every instruction 
+// after it, until the next record) comes from provided line and column. 
+// Offsets must be recorded in increasing order. Returns 'false' if 
+// allocation fails.
+
+bool promit_PositionTable_add(PositionTable* table, PromitAllocator* allocator, 
+    int offset, int line, int column) 
+{
+    // Nothing to record if the position didn't change. The first entry is 
+    // always recorded.
+
+    if(table -> count != 0 && line == table -> last_line && 
+        column == table -> last_column) 
+    {
+        return true;
+    }
+
+    // Header, 2 varints and a column varint.
+
+    if(unlikely(!reserve(table, allocator, 16))) 
+        return false;
+    
+    int offset_delta = offset - table -> last_offset;
+    int line_delta   = line - table -> last_line;
+
+    // The first entry can start at offset 0, which the short form can't 
+    // express.
+
+    if(offset_delta >= 1 && offset_delta <= 16 && 
+        line_delta >= 0 && line_delta <= 7) 
+    {
+        table -> bytes[table -> count++] = 
+            (uint8_t) ((line_delta << 4) | (offset_delta - 1));
+    }
+    else {
+        table -> bytes[table -> count++] = 0x80u;
+
+        write_varint(table, (uint32_t) offset_delta);
+        write_svarint(table, line_delta);
+    }
+
+    if(line_delta == 0) 
+        write_svarint(table, column - table -> last_column);
+    else 
+        write_varint(table, (uint32_t) column);
+
+    table -> last_offset = offset;
+    table -> last_line   = line;
+    table -> last_column = column;
+
+    return true;
+}
+
+// bool promit_PositionTable_lookup(const uint8_t*, int, int, int*, int*);
+// 
+// Decodes the line and column of the instruction at provided offset from 
+// the provided encoded bytes. Returns 'false' if the offset comes before the 
+// first entry.
+
+bool promit_PositionTable_lookup(const uint8_t* bytes, int count, int offset, 
+    int* line, int* column) 
+{
+    const uint8_t* end = bytes + count;
+
+    int current_offset = 0, current_line = 1, current_column = 0;
+
+    bool found = false;
+
+    while(bytes < end) {
+        uint8_t header = *bytes++;
+
+        int offset_delta, line_delta;
+
+        if(likely(!(header & 0x80u))) {
+            offset_delta = (header & 0x0F) + 1;
+            line_delta   = header >> 4;
+        }
+        else {
+            offset_delta = (int) read_varint(&bytes);
+            line_delta   = read_svarint(&bytes);
+        }
+
+        // The entry starts past the offset we are looking for, so the 
+        // previous entry covers it.
+
+        if(current_offset + offset_delta > offset && found) 
+            break;
+        
+        current_offset += offset_delta;
+        current_line   += line_delta;
+
+        if(line_delta == 0) 
+            current_column += read_svarint(&bytes);
+        else 
+            current_column = (int) read_varint(&bytes);
+        
+        // The first entry may still start past the offset.
+
+        if(current_offset > offset) 
+            return false;
+
+        found = true;
+    }
+
+    if(found) {
+        *line   = current_line;
+        *column = current_column;
+    }
+
+    return found;
+}
+
+// void promit_PositionTable_free(PositionTable*, PromitAllocator*);
+// 
+// Frees the position table.
+
+void promit_PositionTable_free(PositionTable* table, 
+    PromitAllocator* allocator) 
+{
+    allocator -> allocate(allocator -> user_data, table -> bytes, 
+        (size_t) table -> capacity, 0u, _Alignof(uint8_t));
+    
+    promit_PositionTable_init(table);
+}
@@ -37,6 +37,9 @@ static Token make_token(Scanner* scanner, TokenType type) {
     token.length = (int) (scanner -> current - scanner -> start);
     token.value  = 0;
 
+    token.integer    = 0;
+    token.is_integer = false;
+
     return token;
 }
 
@@ -62,10 +65,16 @@ static bool is_at_end(Scanner* scanner) {
 // Returns an unexpected character error.
 
 static Token unexpected_character(Scanner* scanner) {
-    char buffer[26];
+    // The message is kept in the scanner, so that the token doesn't point to 
+    // a dead stack buffer.
+
+    char* buffer = scanner -> error;
+
+    // The unexpected character has already been consumed, it's at the start 
+    // of the token.
 
     memcpy(buffer, "Unexpected character '", 22u * sizeof(char));
-    memcpy(buffer + 22u, scanner -> current, sizeof(char));
+    memcpy(buffer + 22u, scanner -> start, sizeof(char));
     memcpy(buffer + 23u, "'!", 2u * sizeof(char));
 
     buffer[25] = '\0';
@@ -235,39 +244,107 @@ static bool is_digit(char ch) {
     return ch >= '0' && ch <= '9';
 }
 
-// Emits a number token.
+// Returns the value of a hexadecimal (or binary/decimal) digit character.
+
+static int digit_value(char ch) {
+    if(ch >= '0' && ch <= '9') return ch - '0';
+    if(ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+
+    return ch - 'A' + 10;
+}
+
+// Emits a number token. Decimal numbers are integers if [is_integer] is set, 
+// hexadecimal and binary numbers always are.
+
+static Token make_number(Scanner* scanner, NumberType type, bool is_integer) {
+    static const char* const too_large = 
+        "Number literal was too large to be converted. "
+        "Make sure it fits within 64-bit integer.";
 
-static Token make_number(Scanner* scanner, NumberType type) {
     // Reset the error message number <errno.h>.
 
     errno = 0;
 
     double num = -1;
 
+    int64_t integer = 0;
+
+    // Where the conversion stopped, which must be the end of the token.
+
+    char* end = NULL;
+
     switch(type) {
         case NUMBER_TYPE_DECIMAL: 
-            num = strtod(scanner -> start, NULL);
+            if(likely(is_integer)) {
+                integer = (int64_t) strtoll(scanner -> start, &end, 10);
+
+                // Doesn't fit in 64-bit integer, read it as a double 
+                // instead.
+
+                if(unlikely(errno == ERANGE)) {
+                    is_integer = false;
+                    integer    = 0;
+
+                    errno = 0;
+                }
+            }
+
+            if(is_integer) 
+                num = (double) integer;
+            else 
+                num = strtod(scanner -> start, &end);
+
+            if(errno == ERANGE) 
+                return error_token(scanner, too_large);
+
+            if(unlikely(end != scanner -> current)) 
+                return error_token(scanner, "Malformed number literal!");
+
             break;
         
+        // Hexadecimal and binary literals are bit patterns, so the full 64 
+        // bits are read unsigned. Only the digits of the token after the 
+        // '0x'/'0b' prefix are read.
+
         case NUMBER_TYPE_HEXADECIMAL: 
-            num = (double) strtoll(scanner -> start, NULL, 16);
-            break;
-        
-        case NUMBER_TYPE_BINARY: 
-            num = (double) strtoll(scanner -> start, NULL, 2);
+        case NUMBER_TYPE_BINARY: {
+            unsigned shift = type == NUMBER_TYPE_HEXADECIMAL ? 4u : 1u;
+
+            const char* digit = scanner -> start + 2;
+
+            if(unlikely(digit == scanner -> current)) {
+                return error_token(scanner, type == NUMBER_TYPE_HEXADECIMAL ? 
+                    "Expected hexadecimal digits after '0x'!" : 
+                    "Expected binary digits after '0b'!");
+            }
+
+            uint64_t bits = 0u;
+
+            for(; digit < scanner -> current; digit++) {
+                // Shifting in another digit would drop the high bits.
+
+                if(unlikely(bits >> (64u - shift) != 0u)) 
+                    return error_token(scanner, too_large);
+
+                bits = (bits << shift) | (uint64_t) digit_value(*digit);
+            }
+
+            // The magnitude stays unsigned in [num], only [integer] holds 
+            // the reinterpreted bit pattern.
+
+            integer = (int64_t) bits;
+            num     = (double) bits;
             break;
+        }
         
         default: UNREACHABLE();
     }
 
-    if(errno == ERANGE) 
-        return error_token(scanner, 
-            "Number literal was too large to be converted. "
-            "Make sure it fits within 64-bit integer.");
-
     Token token = make_token(scanner, TOKEN_NUMBER);
 
-    token.value = num;
+    token.value      = num;
+    token.integer    = integer;
+    token.is_integer = is_integer;
 
     return token;
 }
@@ -275,12 +352,18 @@ static Token make_number(Scanner* scanner, NumberType type) {
 // Lexes through a decimal number.
 
 static Token read_number(Scanner* scanner) {
+    // Whether the number has no fraction or exponent.
+
+    bool is_integer = true;
+
     // Read through all the leading digits.
 
     while(is_digit(PEEK())) 
         ADVANCE();
     
     if(likely(MATCH('.'))) {
+        is_integer = false;
+
         // Consume all the digits after that.
 
         while(is_digit(PEEK())) 
@@ -288,7 +371,9 @@ static Token read_number(Scanner* scanner) {
     }
 
     if(MATCH('e') || MATCH('E')) {
-        if(MATCH('+')) MATCH('-');
+        is_integer = false;
+
+        if(!MATCH('+')) MATCH('-');
 
         if(unlikely(!is_digit(PEEK())))  
             return error_token(scanner, "Unterminated scientific notation!");
@@ -299,7 +384,7 @@ static Token read_number(Scanner* scanner) {
             ADVANCE();
     }
 
-    return make_number(scanner, NUMBER_TYPE_DECIMAL);
+    return make_number(scanner, NUMBER_TYPE_DECIMAL, is_integer);
 }
 
 // Lexes through a hexadecimal number.
@@ -316,7 +401,7 @@ static Token read_hex_number(Scanner* scanner) {
         ch = PEEK();
     }
 
-    return make_number(scanner, NUMBER_TYPE_HEXADECIMAL);
+    return make_number(scanner, NUMBER_TYPE_HEXADECIMAL, true);
 }
 
 // Lexes through a binary number.
@@ -330,7 +415,7 @@ static Token read_bin_number(Scanner* scanner) {
         ch = PEEK();
     }
 
-    return make_number(scanner, NUMBER_TYPE_BINARY);
+    return make_number(scanner, NUMBER_TYPE_BINARY, true);
 }
 
 // Check whether provided character is an alphabetical character.